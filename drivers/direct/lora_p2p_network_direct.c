@@ -9,6 +9,7 @@
 
 #include "lora_p2p_network_direct.h"
 #include "lora_p2p_network_layer.h"
+#include "lora_p2p_trace.h"
 #include "zephyr/sys/ring_buffer.h"
 
 #include <stdint.h>
@@ -25,9 +26,18 @@ LOG_MODULE_REGISTER(P2PDirect, CONFIG_LBM_P2P_NETWORK_LOG_LEVEL);
 */
 #define LORA_P2P_NETWORK_DIRECT_HEADER_LENGTH 2
 
+// longest single listen, a waiting sender gets the radio between slices
+#define LORA_P2P_NETWORK_DIRECT_RECV_SLICE K_MSEC(CONFIG_LBM_P2P_NETWORK_DIRECT_RECV_SLICE_MS)
+
 struct lora_p2p_network_direct_data_t {
     // this node id
     uint8_t my_id;
+
+    // serializes access to the (half duplex) radio
+    struct k_mutex radio_lock;
+
+    // senders waiting for the radio, a receive only lets go of it for them
+    atomic_t tx_waiting;
 };
 
 struct lora_p2p_network_direct_config_t {
@@ -35,10 +45,24 @@ struct lora_p2p_network_direct_config_t {
     const struct device *lora_dev;
 };
 
+/* Internal
+*/
+// next listen duration: the remaining time, capped at one slice
+static k_timeout_t recv_slice(k_timepoint_t end) {
+    k_timeout_t remaining = sys_timepoint_timeout(end);
+
+    if (K_TIMEOUT_EQ(remaining, K_FOREVER) || remaining.ticks > LORA_P2P_NETWORK_DIRECT_RECV_SLICE.ticks) {
+        return LORA_P2P_NETWORK_DIRECT_RECV_SLICE;
+    }
+
+    return remaining;
+}
+
 /* Driver init
 */
 static int lora_p2p_network_direct_init(const struct device *dev) {
     const struct lora_p2p_network_direct_config_t *config = dev->config;
+    struct lora_p2p_network_direct_data_t *data = dev->data;
 
     // make sure lora device is ready
     if (!device_is_ready(config->lora_dev)) {
@@ -46,6 +70,10 @@ static int lora_p2p_network_direct_init(const struct device *dev) {
         return -EINVAL;
     }
 
+    // radio is shared between all callers
+    k_mutex_init(&data->radio_lock);
+    atomic_set(&data->tx_waiting, 0);
+
     LOG_INF("LoRa network layer ready");
 
     return 0;
@@ -73,6 +101,12 @@ static int lora_p2p_network_set_node_id_direct(const struct device *dev, uint8_t
 	return 0;
 }
 
+static uint8_t lora_p2p_network_get_node_id_direct(const struct device *dev) {
+    const struct lora_p2p_network_direct_data_t *data = dev->data;
+
+    return data->my_id;
+}
+
 static int lora_p2p_network_send_direct(const struct device *dev, uint8_t to, struct ring_buf *rb) {
     const struct lora_p2p_network_direct_config_t *config = dev->config;
     struct lora_p2p_network_direct_data_t *data = dev->data;
@@ -100,8 +134,16 @@ static int lora_p2p_network_send_direct(const struct device *dev, uint8_t to, st
     uint8_t *packet;
     uint32_t packet_size = ring_buf_get_claim(rb, &packet, ring_buf_size_get(rb));
 
-    // do the sending
+    // do the sending (radio is ours for the duration of the transmission)
+    atomic_inc(&data->tx_waiting);
+    k_mutex_lock(&data->radio_lock, K_FOREVER);
+    atomic_dec(&data->tx_waiting);
     int retcode = lbm_send(config->lora_dev, packet, packet_size);
+    k_mutex_unlock(&data->radio_lock);
+
+    lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_NETWORK, LORA_P2P_TRACE_DIR_TX,
+        retcode < 0 ? LORA_P2P_TRACE_OUTCOME_SEND_ERROR : LORA_P2P_TRACE_OUTCOME_SENT,
+        0, data->my_id, to, packet_size, 0, 0);
 
     // finish the claim
     ring_buf_get_finish(rb, packet_size);
@@ -126,10 +168,26 @@ static int lora_p2p_network_recv_direct(const struct device *dev, struct lora_p2
     uint8_t *packet, from, to;
     uint32_t available_size = ring_buf_put_claim(rb, &packet, lbm_get_mtu(config->lora_dev));
 
+    // caller's timeout covers all slices
+    k_timepoint_t end = sys_timepoint_calc(timeout);
+
     // keep trying to recv until we get something for us
+    k_mutex_lock(&data->radio_lock, K_FOREVER);
     while (true) {
         // do the receiving
-        int recv_len = lbm_recv(config->lora_dev, packet, available_size, timeout, &meta->rssi, &meta->snr);
+        int recv_len = lbm_recv(config->lora_dev, packet, available_size, recv_slice(end), &meta->rssi, &meta->snr);
+
+        // slice over with nothing heard ? listen again unless caller's time is up
+        if ((recv_len == -EAGAIN || recv_len == -ETIMEDOUT) && !sys_timepoint_expired(end)) {
+            // only stop listening if a sender is waiting (mutex hands it the radio, we get it back after)
+            if (atomic_get(&data->tx_waiting) > 0) {
+                k_mutex_unlock(&data->radio_lock);
+                k_mutex_lock(&data->radio_lock, K_FOREVER);
+            }
+            continue;
+        }
+
+        k_mutex_unlock(&data->radio_lock);
 
         // error ? return it here
         if (recv_len < 0) return recv_len;
@@ -140,7 +198,14 @@ static int lora_p2p_network_recv_direct(const struct device *dev, struct lora_p2
         LOG_DBG("Got packet (size = %d, from = %d, to = %d)", recv_len, from, to);
 
         // is it for us ?
-        if (data->my_id != to && to != LORA_P2P_BROADCAST_ID) continue;
+        if (data->my_id != to && to != LORA_P2P_BROADCAST_ID) {
+            lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_NETWORK, LORA_P2P_TRACE_DIR_RX, LORA_P2P_TRACE_OUTCOME_FILTERED,
+                0, from, to, recv_len, meta->rssi, meta->snr);
+
+            // waiting senders (if any) go first, then back to listening
+            k_mutex_lock(&data->radio_lock, K_FOREVER);
+            continue;
+        }
 
         // update meta data
         meta->from = from;
@@ -148,9 +213,14 @@ static int lora_p2p_network_recv_direct(const struct device *dev, struct lora_p2
 
         // finish the claim (get rid of the header while at it)
         if (ring_buf_put_finish(rb, recv_len-LORA_P2P_NETWORK_DIRECT_HEADER_LENGTH) < 0) {
+            lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_NETWORK, LORA_P2P_TRACE_DIR_RX, LORA_P2P_TRACE_OUTCOME_DROPPED,
+                0, from, to, recv_len, meta->rssi, meta->snr);
             LOG_ERR("lora_p2p_network_recv_direct(): Recv too big");
             return -ENOMEM;
         }
+
+        lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_NETWORK, LORA_P2P_TRACE_DIR_RX, LORA_P2P_TRACE_OUTCOME_DELIVERED,
+            0, from, to, recv_len, meta->rssi, meta->snr);
         
         LOG_DBG("Received %d bytes from %d", ring_buf_size_get(rb), meta->from);
 
@@ -171,6 +241,7 @@ static DEVICE_API(lora_p2p_network, lora_p2p_network_api) = {
     .get_link_device = lora_p2p_network_get_link_device_direct,
     .get_mtu =         lora_p2p_network_get_mtu_direct,
     .set_node_id =     lora_p2p_network_set_node_id_direct,
+    .get_node_id =     lora_p2p_network_get_node_id_direct,
     .send =            lora_p2p_network_send_direct,
     .recv =            lora_p2p_network_recv_direct
 };
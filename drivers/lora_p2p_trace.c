@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2026 Cerbercomm LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Maintained by:
+ *   2026-10-18 agent
+ */
+
+#include "lora_p2p_trace.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+#include <zephyr/sys/util.h>
+
+#ifdef CONFIG_LBM_P2P_TRACE_SHELL
+# include <zephyr/shell/shell.h>
+#endif
+
+#ifdef CONFIG_LBM_P2P_TRACE_NATIVE_FILE
+# include "lora_p2p_trace_native_bottom.h"
+#endif
+
+/* Definitions
+*/
+#define LORA_P2P_TRACE_MASK (CONFIG_LBM_P2P_TRACE_ENTRIES - 1)
+
+// shell pcap framing, data lines carry a prefix so interleaved log lines can be filtered out
+#define LORA_P2P_TRACE_PCAP_BEGIN  "-----BEGIN LORA P2P PCAP-----"
+#define LORA_P2P_TRACE_PCAP_END    "-----END LORA P2P PCAP-----"
+#define LORA_P2P_TRACE_PCAP_PREFIX "pcap: "
+
+// bytes per shell pcap data line
+#define LORA_P2P_TRACE_PCAP_LINE   32
+
+BUILD_ASSERT(IS_POWER_OF_TWO(CONFIG_LBM_P2P_TRACE_ENTRIES), "CONFIG_LBM_P2P_TRACE_ENTRIES must be a power of two");
+
+// pcap (microsecond resolution) file header
+struct lora_p2p_trace_pcap_header_t {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+} __packed;
+
+// pcap per packet header
+struct lora_p2p_trace_pcap_record_t {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t incl_len;
+    uint32_t orig_len;
+} __packed;
+
+struct lora_p2p_trace_slot_t {
+    // seq+1 of the record held, 0 while being written
+    atomic_t stamp;
+
+    struct lora_p2p_trace_entry_t entry;
+};
+
+/* Internal
+*/
+static struct lora_p2p_trace_slot_t ring[CONFIG_LBM_P2P_TRACE_ENTRIES];
+
+// next record number to hand out
+static atomic_t head;
+
+// first record number still of interest (moved by clear)
+static atomic_t tail;
+
+static uint64_t timestamp_us(void) {
+#ifdef CONFIG_TIMER_HAS_64BIT_CYCLE_COUNTER
+    return k_cyc_to_us_floor64(k_cycle_get_64());
+#else
+    return k_ticks_to_us_floor64(k_uptime_ticks());
+#endif
+}
+
+// copy a record out of the ring, false if it was overwritten meanwhile
+static bool read_slot(uint32_t seq, struct lora_p2p_trace_entry_t *entry) {
+    struct lora_p2p_trace_slot_t *slot = &ring[seq & LORA_P2P_TRACE_MASK];
+
+    if ((uint32_t)atomic_get(&slot->stamp) != seq + 1) return false;
+
+    memcpy(entry, &slot->entry, sizeof(*entry));
+
+    // copy must complete before the stamp is checked again
+    barrier_dmem_fence_full();
+
+    // writer may have lapped us while copying
+    return (uint32_t)atomic_get(&slot->stamp) == seq + 1;
+}
+
+/* API
+*/
+void lora_p2p_trace_record(enum lora_p2p_trace_layer_t layer, enum lora_p2p_trace_direction_t direction,
+    enum lora_p2p_trace_outcome_t outcome, uint8_t header, uint8_t from, uint8_t to, uint16_t length,
+    int16_t rssi, int8_t snr) {
+    // claim a slot
+    uint32_t seq = (uint32_t)atomic_inc(&head);
+    struct lora_p2p_trace_slot_t *slot = &ring[seq & LORA_P2P_TRACE_MASK];
+
+    // invalidate slot while we fill it (visible before any of the stores below)
+    atomic_set(&slot->stamp, 0);
+    barrier_dmem_fence_full();
+
+    slot->entry.seq = seq;
+    slot->entry.timestamp_us = timestamp_us();
+    slot->entry.layer = layer;
+    slot->entry.direction = direction;
+    slot->entry.outcome = outcome;
+    slot->entry.header = header;
+    slot->entry.from = from;
+    slot->entry.to = to;
+    slot->entry.length = length;
+    slot->entry.rssi = rssi;
+    slot->entry.snr = snr;
+    slot->entry.reserved = 0;
+
+    // publish (entry stores complete first)
+    barrier_dmem_fence_full();
+    atomic_set(&slot->stamp, seq + 1);
+}
+
+int lora_p2p_trace_foreach(lora_p2p_trace_cb_t cb, void *user_data) {
+    struct lora_p2p_trace_entry_t entry;
+    uint32_t end = (uint32_t)atomic_get(&head);
+    uint32_t seq = (uint32_t)atomic_get(&tail);
+    int count = 0;
+
+    // only the last CONFIG_LBM_P2P_TRACE_ENTRIES records survive
+    if (end - seq > CONFIG_LBM_P2P_TRACE_ENTRIES) seq = end - CONFIG_LBM_P2P_TRACE_ENTRIES;
+
+    for (; seq != end; seq++) {
+        // still being written or already overwritten
+        if (!read_slot(seq, &entry)) continue;
+
+        count++;
+        if (cb(&entry, user_data)) break;
+    }
+
+    return count;
+}
+
+struct pcap_export_ctx_t {
+    lora_p2p_trace_write_cb_t write;
+    void *user_data;
+    int retcode;
+};
+
+static int pcap_export_entry(const struct lora_p2p_trace_entry_t *entry, void *user_data) {
+    struct pcap_export_ctx_t *ctx = user_data;
+    struct lora_p2p_trace_pcap_record_t record = {
+        .ts_sec = (uint32_t)(entry->timestamp_us / USEC_PER_SEC),
+        .ts_usec = (uint32_t)(entry->timestamp_us % USEC_PER_SEC),
+        .incl_len = sizeof(*entry),
+        .orig_len = sizeof(*entry),
+    };
+
+    ctx->retcode = ctx->write(&record, sizeof(record), ctx->user_data);
+    if (ctx->retcode < 0) return 1;
+
+    ctx->retcode = ctx->write(entry, sizeof(*entry), ctx->user_data);
+    return ctx->retcode < 0;
+}
+
+int lora_p2p_trace_pcap_export(lora_p2p_trace_write_cb_t write, void *user_data) {
+    struct pcap_export_ctx_t ctx = { .write = write, .user_data = user_data, .retcode = 0 };
+    const struct lora_p2p_trace_pcap_header_t header = {
+        .magic = 0xa1b2c3d4,
+        .version_major = 2,
+        .version_minor = 4,
+        .thiszone = 0,
+        .sigfigs = 0,
+        .snaplen = sizeof(struct lora_p2p_trace_entry_t),
+        .linktype = CONFIG_LBM_P2P_TRACE_PCAP_LINKTYPE,
+    };
+    int count;
+
+    ctx.retcode = write(&header, sizeof(header), user_data);
+    if (ctx.retcode < 0) return ctx.retcode;
+
+    count = lora_p2p_trace_foreach(pcap_export_entry, &ctx);
+
+    return ctx.retcode < 0 ? ctx.retcode : count;
+}
+
+void lora_p2p_trace_clear(void) {
+    atomic_set(&tail, atomic_get(&head));
+}
+
+#ifdef CONFIG_LBM_P2P_TRACE_NATIVE_FILE
+static int native_file_write(const void *buf, size_t len, void *user_data) {
+    int fd = *(int *)user_data;
+
+    return lora_p2p_trace_native_write(fd, buf, len) < 0 ? -EIO : 0;
+}
+
+int lora_p2p_trace_pcap_export_file(const char *path) {
+    int fd = lora_p2p_trace_native_open(path);
+    int retcode;
+
+    if (fd < 0) return -EIO;
+
+    retcode = lora_p2p_trace_pcap_export(native_file_write, &fd);
+    lora_p2p_trace_native_close(fd);
+
+    return retcode;
+}
+#endif  // CONFIG_LBM_P2P_TRACE_NATIVE_FILE
+
+/* Shell
+*/
+#ifdef CONFIG_LBM_P2P_TRACE_SHELL
+static const char * const layer_str[] = { "NET", "TRN" };
+static const char * const direction_str[] = { "RX", "TX" };
+static const char * const outcome_str[] = { "sent", "send-error", "delivered", "filtered", "dropped", "ack-timeout" };
+
+static int shell_dump_entry(const struct lora_p2p_trace_entry_t *entry, void *user_data) {
+    const struct shell *sh = user_data;
+
+    shell_print(sh, "%6u [%llu.%06llu] %s %s %-11s %3u -> %3u hdr 0x%02x len %3u rssi %4d snr %3d",
+        entry->seq,
+        (unsigned long long)(entry->timestamp_us / USEC_PER_SEC),
+        (unsigned long long)(entry->timestamp_us % USEC_PER_SEC),
+        entry->layer < ARRAY_SIZE(layer_str) ? layer_str[entry->layer] : "?",
+        entry->direction < ARRAY_SIZE(direction_str) ? direction_str[entry->direction] : "?",
+        entry->outcome < ARRAY_SIZE(outcome_str) ? outcome_str[entry->outcome] : "?",
+        entry->from, entry->to, entry->header, entry->length, entry->rssi, entry->snr);
+
+    return 0;
+}
+
+// one complete line per shell_fprintf() call, so log output can only land between lines
+static int shell_write_hex(const void *buf, size_t len, void *user_data) {
+    const struct shell *sh = user_data;
+    const uint8_t *bytes = buf;
+    char line[LORA_P2P_TRACE_PCAP_LINE * 2 + 1];
+
+    while (len > 0) {
+        size_t chunk = MIN(len, LORA_P2P_TRACE_PCAP_LINE);
+
+        bin2hex(bytes, chunk, line, sizeof(line));
+        shell_fprintf(sh, SHELL_NORMAL, LORA_P2P_TRACE_PCAP_PREFIX "%s\n", line);
+
+        bytes += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+static int cmd_trace_dump(const struct shell *sh, size_t argc, char **argv) {
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    shell_print(sh, "%d records", lora_p2p_trace_foreach(shell_dump_entry, (void *)sh));
+
+    return 0;
+}
+
+static int cmd_trace_pcap(const struct shell *sh, size_t argc, char **argv) {
+    int retcode;
+
+#ifdef CONFIG_LBM_P2P_TRACE_NATIVE_FILE
+    // native_sim: write straight to a host file
+    if (argc > 1) {
+        retcode = lora_p2p_trace_pcap_export_file(argv[1]);
+        if (retcode < 0) {
+            shell_error(sh, "Failed writing %s (%d)", argv[1], retcode);
+            return retcode;
+        }
+
+        shell_print(sh, "%d records written to %s", retcode, argv[1]);
+        return 0;
+    }
+#else
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+#endif
+
+    // framed hex stream, see README for turning it back into a pcap file
+    shell_print(sh, LORA_P2P_TRACE_PCAP_BEGIN);
+    retcode = lora_p2p_trace_pcap_export(shell_write_hex, (void *)sh);
+    shell_print(sh, LORA_P2P_TRACE_PCAP_END);
+
+    return retcode < 0 ? retcode : 0;
+}
+
+static int cmd_trace_clear(const struct shell *sh, size_t argc, char **argv) {
+    ARG_UNUSED(argc);
+    ARG_UNUSED(argv);
+
+    lora_p2p_trace_clear();
+    shell_print(sh, "Trace cleared");
+
+    return 0;
+}
+
+SHELL_STATIC_SUBCMD_SET_CREATE(sub_lora_trace,
+    SHELL_CMD(dump, NULL, "Print trace records", cmd_trace_dump),
+#ifdef CONFIG_LBM_P2P_TRACE_NATIVE_FILE
+    SHELL_CMD_ARG(pcap, NULL, "Export trace as pcap: [host file], hex on the console without one", cmd_trace_pcap, 1, 1),
+#else
+    SHELL_CMD(pcap, NULL, "Export trace as hex encoded pcap", cmd_trace_pcap),
+#endif
+    SHELL_CMD(clear, NULL, "Clear trace records", cmd_trace_clear),
+    SHELL_SUBCMD_SET_END
+);
+
+SHELL_CMD_REGISTER(lora_trace, &sub_lora_trace, "LoRa P2P frame trace", NULL);
+#endif  // CONFIG_LBM_P2P_TRACE_SHELL
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2026 Cerbercomm LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Maintained by:
+ *   2026-10-18 agent
+ */
+
+// runs on the host (native_sim runner), so this uses the host libc directly
+
+#include "lora_p2p_trace_native_bottom.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+int lora_p2p_trace_native_open(const char *path) {
+    return open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+int lora_p2p_trace_native_write(int fd, const void *buf, size_t len) {
+    const char *bytes = buf;
+
+    while (len > 0) {
+        ssize_t written = write(fd, bytes, len);
+
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        bytes += written;
+        len -= written;
+    }
+
+    return 0;
+}
+
+void lora_p2p_trace_native_close(int fd) {
+    close(fd);
+}
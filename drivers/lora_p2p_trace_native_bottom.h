@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2026 Cerbercomm LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Maintained by:
+ *   2026-10-18 agent
+ */
+
+#ifndef LORA_P2P_TRACE_NATIVE_BOTTOM_H
+#define LORA_P2P_TRACE_NATIVE_BOTTOM_H
+
+// host side of the native_sim pcap file sink, plain C types only (built against the host libc)
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// create / truncate a host file, returns a descriptor or -1
+int lora_p2p_trace_native_open(const char *path);
+
+// write all of buf, returns 0 or -1
+int lora_p2p_trace_native_write(int fd, const void *buf, size_t len);
+
+void lora_p2p_trace_native_close(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LORA_P2P_TRACE_NATIVE_BOTTOM_H
@@ -10,6 +10,7 @@
 #include "lora_p2p_transport.h"
 #include "lora_p2p_transport_layer.h"
 #include "lora_p2p_network_layer.h"
+#include "lora_p2p_trace.h"
 
 #include "zephyr/sys/ring_buffer.h"
 
@@ -29,16 +30,103 @@ LOG_MODULE_REGISTER(P2PTrans, CONFIG_LBM_P2P_TRANSPORT_LOG_LEVEL);
 #else
 # error "LoRa Hardware is not defined"
 #endif
-static uint8_t packet_buffer[LBM_BUFFER_SIZE_MAX];
 
-struct lora_p2p_transport_data_t {
-    // ring buffer for IO
-    struct ring_buf rb;
+// how long we wait for the peer to Ack a fragment
+#define LBM_TRANSPORT_ACK_TIMEOUT     K_MSEC(CONFIG_LBM_P2P_TRANSPORT_ACK_TIMEOUT_MS)
+
+// how long other senders stay off the air so a prompt Ack is not talked over
+#define LBM_TRANSPORT_ACK_TURNAROUND  K_MSEC(CONFIG_LBM_P2P_TRANSPORT_ACK_TURNAROUND_MS)
+
+// back off after a failed receive before listening again
+#define LBM_TRANSPORT_RX_ERROR_BACKOFF K_MSEC(100)
+
+// ** Session **
+// all traffic with a single peer: its own fragment buffers and Ack signalling,
+// so transfers to different peers never share state
+struct lora_p2p_transport_session_t {
+    // is this slot taken ?
+    bool in_use;
+
+    // peer node id
+    uint8_t peer;
+
+    // uptime (ms) of last activity, used to recycle idle sessions
+    uint32_t last_activity;
+
+    // -- transmit side --
+    // one transfer at a time towards this peer
+    struct k_mutex tx_lock;
+
+    // senders using (or waiting on) this session, it is not recycled while > 0
+    uint8_t tx_users;
+
+    // a sender is waiting for the peer to Ack its last fragment
+    bool awaiting_ack;
+
+    // when that sender gives up, the receiver is kept listening until then
+    k_timepoint_t ack_deadline;
+
+    // given by the rx thread when the peer Acks
+    struct k_sem ack_sem;
+
+    // ring buffer for outgoing fragments
+    struct ring_buf tx_rb;
+    uint8_t tx_buffer[LBM_BUFFER_SIZE_MAX];
+
+    // -- receive side --
+    // a multi packet train is being reassembled
+    bool rx_active;
 
+    // uptime (ms) of the last fragment, a stalled train is abandoned after the reassembly timeout
+    uint32_t rx_last_fragment;
+
+    // a complete message is waiting for recv()
+    bool rx_ready;
+
+    // meta data of the last fragment received
+    struct lora_p2p_transport_incoming_t rx_meta;
+
+    // reassembly buffer
+    struct ring_buf rx_rb;
+    uint8_t rx_buffer[CONFIG_LBM_P2P_TRANSPORT_MAX_MESSAGE_SIZE];
+};
+
+struct lora_p2p_transport_data_t {
     // network layer lora device
     const struct device *lora_network_dev;
+
+    // held by a sender from its transmission through the expected Ack turnaround,
+    // so no other sender talks over the peer's answer
+    struct k_mutex air_lock;
+
+    // per peer sessions (table guarded by sessions_lock)
+    struct lora_p2p_transport_session_t sessions[CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS];
+    struct k_mutex sessions_lock;
+
+    // indices of sessions holding a complete message
+    struct k_msgq rx_msgq;
+    char rx_msgq_buffer[CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS * sizeof(uint8_t)];
+
+    // recv() callers waiting for a message (guarded by sessions_lock)
+    uint32_t recv_pending;
+
+    // receive thread, it only listens while a recv() or an Ack is pending
+    struct k_thread rx_thread;
+
+    // given whenever there is a new reason to listen
+    struct k_sem listen_sem;
+
+    // ring buffer for incoming frames (rx thread only)
+    struct ring_buf rx_rb;
+    uint8_t rx_buffer[LBM_BUFFER_SIZE_MAX];
+
+    // ring buffer for outgoing Acks (rx thread only)
+    struct ring_buf ack_rb;
+    uint8_t ack_buffer[LBM_BUFFER_SIZE_MAX];
 };
 
+static K_THREAD_STACK_DEFINE(lora_p2p_transport_rx_stack, CONFIG_LBM_P2P_TRANSPORT_RX_STACK_SIZE);
+
 // ** Header **
 // mask for packet type
 #define LBM_TRANSPORT_HEADER_TYPE_MASK        0b111
@@ -66,76 +154,314 @@ struct lora_p2p_transport_data_t {
 
 /* Internal
 */
-static bool is_ack_packet(struct ring_buf *rb) {
-    uint8_t header;
+static void prepare_ack(struct ring_buf *rb) {
+    uint8_t header = LBM_TRANSPORT_HEADER_TYPE_ACK;
 
-    // must be just a header
-    if (ring_buf_size_get(rb) != 1) return false;
+    ring_buf_reset(rb);
+    ring_buf_put(rb, &header, 1);
+}
 
-    // get header
-    ring_buf_get(rb, &header, 1);
+// has the peer stopped feeding an unfinished train ?
+static bool session_rx_expired(struct lora_p2p_transport_session_t *session, uint32_t now) {
+    return session->rx_active && (now - session->rx_last_fragment) > CONFIG_LBM_P2P_TRANSPORT_REASSEMBLY_TIMEOUT_MS;
+}
+
+// find the session of a peer (caller holds sessions_lock)
+static struct lora_p2p_transport_session_t * session_find(struct lora_p2p_transport_data_t *data, uint8_t peer) {
+    for (int i = 0; i < CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS; i++) {
+        if (data->sessions[i].in_use && data->sessions[i].peer == peer) return &data->sessions[i];
+    }
 
-    // check type
-    return (header & LBM_TRANSPORT_HEADER_TYPE_MASK) == LBM_TRANSPORT_HEADER_TYPE_ACK;
+    return NULL;
 }
 
-static void prepare_ack(struct ring_buf *rb) {
-    uint8_t header = LBM_TRANSPORT_HEADER_TYPE_ACK;
+// find or allocate the session of a peer (caller holds sessions_lock)
+static struct lora_p2p_transport_session_t * session_get(struct lora_p2p_transport_data_t *data, uint8_t peer) {
+    struct lora_p2p_transport_session_t *session = session_find(data, peer);
+    uint32_t now = k_uptime_get_32();
 
-    ring_buf_reset(rb);
-    ring_buf_put(rb, &header, 1);
+    if (session) return session;
+
+    // prefer a free slot, otherwise recycle the least recently used idle session
+    for (int i = 0; i < CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS; i++) {
+        struct lora_p2p_transport_session_t *candidate = &data->sessions[i];
+
+        if (!candidate->in_use) {
+            session = candidate;
+            break;
+        }
+
+        // busy sessions can not be recycled (a stalled reassembly does not count as busy)
+        if (candidate->tx_users > 0 || candidate->rx_ready) continue;
+        if (candidate->rx_active && !session_rx_expired(candidate, now)) continue;
+
+        if (!session || (now - candidate->last_activity) > (now - session->last_activity)) session = candidate;
+    }
+
+    if (!session) return NULL;
+
+    LOG_DBG("Session %d assigned to %d", (int)(session - data->sessions), peer);
+
+    session->in_use = true;
+    session->peer = peer;
+    session->last_activity = now;
+    session->tx_users = 0;
+    session->awaiting_ack = false;
+    session->rx_active = false;
+    session->rx_ready = false;
+    ring_buf_reset(&session->tx_rb);
+    ring_buf_reset(&session->rx_rb);
+    k_sem_reset(&session->ack_sem);
+
+    return session;
 }
 
-/* Driver init
-*/
-static int lora_p2p_transport_init(const struct device *dev) {
-    struct lora_p2p_transport_data_t *data = dev->data;
+// is there a recv() waiting that a new message from this peer's session would go to ?
+// each incoming message (in reassembly or unread) is spoken for by one waiting recv()
+// (caller holds sessions_lock)
+static bool rx_has_reader(struct lora_p2p_transport_data_t *data, struct lora_p2p_transport_session_t *peer) {
+    uint32_t now = k_uptime_get_32();
+    uint32_t claimed = 0;
 
-    // assign inferiour network device
-    data->lora_network_dev = device_get_binding(LORA_P2P_NETWORK_DRIVER_NAME);
+    for (int i = 0; i < CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS; i++) {
+        struct lora_p2p_transport_session_t *session = &data->sessions[i];
 
-    // make sure lora device is ready
-    if (!device_is_ready(data->lora_network_dev)) {
-        LOG_ERR("%s Device not ready", data->lora_network_dev->name);
-        return -EINVAL;
+        // a new message from the peer replaces its unfinished one
+        if (!session->in_use || session == peer) continue;
+
+        if (session->rx_ready || (session->rx_active && !session_rx_expired(session, now))) claimed++;
     }
 
-    // initialize ring buffer
-    ring_buf_init(&data->rb, LBM_BUFFER_SIZE_MAX, packet_buffer);
+    return data->recv_pending > claimed;
+}
 
-    // ready !
-    LOG_INF("LoRa transport layer ready");
+// add an incoming fragment to a session (caller holds sessions_lock)
+// returns true if the fragment was accepted
+static bool session_accept_fragment(struct lora_p2p_transport_data_t *data, struct lora_p2p_transport_session_t *session,
+    uint8_t type, uint8_t *payload, uint32_t payload_size, struct lora_p2p_network_incoming_t *nmeta) {
+    uint32_t now = k_uptime_get_32();
 
-    return 0;
+    // previous message was not picked up yet, peer has to wait
+    if (session->rx_ready) {
+        LOG_WRN("Pending message from %d not received yet, dropping fragment", session->peer);
+        return false;
+    }
+
+    // abandon a train the peer stopped feeding
+    if (session_rx_expired(session, now)) {
+        LOG_WRN("Reassembly from %d timed out", session->peer);
+        ring_buf_reset(&session->rx_rb);
+        session->rx_active = false;
+    }
+
+    switch (type) {
+        case LBM_TRANSPORT_HEADER_TYPE_STAND_ALONE:
+        case LBM_TRANSPORT_HEADER_TYPE_STARTER:
+            // (re)start reassembly
+            ring_buf_reset(&session->rx_rb);
+            session->rx_active = true;
+            break;
+
+        case LBM_TRANSPORT_HEADER_TYPE_CONTINUE:
+        case LBM_TRANSPORT_HEADER_TYPE_FINISHER:
+            if (!session->rx_active) {
+                LOG_WRN("Fragment from %d without a starter, dropping", session->peer);
+                return false;
+            }
+            break;
+
+        default:
+            LOG_WRN("Unknown packet type %d from %d, dropping", type, session->peer);
+            return false;
+    }
+
+    // append payload
+    if (ring_buf_put(&session->rx_rb, payload, payload_size) != payload_size) {
+        LOG_ERR("Message from %d bigger than %d bytes, dropping", session->peer, CONFIG_LBM_P2P_TRANSPORT_MAX_MESSAGE_SIZE);
+        ring_buf_reset(&session->rx_rb);
+        session->rx_active = false;
+        return false;
+    }
+
+    // update meta data
+    session->rx_meta.from = nmeta->from;
+    session->rx_meta.to = nmeta->to;
+    session->rx_meta.rssi = nmeta->rssi;
+    session->rx_meta.snr = nmeta->snr;
+    session->rx_last_fragment = now;
+    session->last_activity = now;
+
+    // done if this was a stand alone packet or a finisher
+    if (type == LBM_TRANSPORT_HEADER_TYPE_STAND_ALONE || type == LBM_TRANSPORT_HEADER_TYPE_FINISHER) {
+        uint8_t index = session - data->sessions;
+
+        session->rx_active = false;
+        session->rx_ready = true;
+
+        // queue never overflows, a session is queued at most once
+        k_msgq_put(&data->rx_msgq, &index, K_NO_WAIT);
+    }
+
+    return true;
 }
 
-/* Driver API
-*/
-static const struct device * lora_p2p_transport_get_network_device_impl(const struct device *dev) {
-    struct lora_p2p_transport_data_t *data = dev->data;
+// dispatch a frame sitting in the rx ring buffer
+static void handle_frame(struct lora_p2p_transport_data_t *data, struct lora_p2p_network_incoming_t *nmeta) {
+    struct lora_p2p_transport_session_t *session;
+    uint8_t header, type, *packet;
+    uint32_t available_size;
+    bool accepted = false;
+    int retcode;
 
-	return data->lora_network_dev;
+    // claim contents
+    available_size = ring_buf_get_claim(&data->rx_rb, &packet, LBM_BUFFER_SIZE_MAX);
+
+    // we MUST have a header
+    if (available_size < 1) {
+        LOG_WRN("Frame from %d without header, dropping", nmeta->from);
+        return;
+    }
+
+    // parse header
+    header = packet[available_size-1];
+    type = header & LBM_TRANSPORT_HEADER_TYPE_MASK;
+
+    k_mutex_lock(&data->sessions_lock, K_FOREVER);
+
+    if (type == LBM_TRANSPORT_HEADER_TYPE_ACK) {
+        // wake up whoever is sending to that peer, stale or duplicate Acks are dropped
+        session = session_find(data, nmeta->from);
+        if (session && session->awaiting_ack) {
+            session->awaiting_ack = false;
+            k_sem_give(&session->ack_sem);
+            accepted = true;
+        } else {
+            LOG_DBG("Unexpected Ack from %d", nmeta->from);
+        }
+    } else if ((type == LBM_TRANSPORT_HEADER_TYPE_STAND_ALONE || type == LBM_TRANSPORT_HEADER_TYPE_STARTER) &&
+        !rx_has_reader(data, session_find(data, nmeta->from))) {
+        // nobody would read it: unAcked, so the sender knows, and no session gets pinned by it
+        LOG_DBG("No recv() waiting, dropping message from %d", nmeta->from);
+    } else {
+        // only a new message may open a session
+        session = (type == LBM_TRANSPORT_HEADER_TYPE_STAND_ALONE || type == LBM_TRANSPORT_HEADER_TYPE_STARTER) ?
+            session_get(data, nmeta->from) :
+            session_find(data, nmeta->from);
+
+        if (session) {
+            accepted = session_accept_fragment(data, session, type, packet, available_size-1, nmeta);
+        } else {
+            LOG_WRN("No session available for %d, dropping fragment", nmeta->from);
+        }
+    }
+
+    k_mutex_unlock(&data->sessions_lock);
+
+    lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_TRANSPORT, LORA_P2P_TRACE_DIR_RX,
+        accepted ? LORA_P2P_TRACE_OUTCOME_DELIVERED : LORA_P2P_TRACE_OUTCOME_DROPPED,
+        header, nmeta->from, nmeta->to, available_size, nmeta->rssi, nmeta->snr);
+
+    // finish claim
+    ring_buf_get_finish(&data->rx_rb, available_size);
+
+    /* Make it reliable if requested
+    */
+    if (accepted && type != LBM_TRANSPORT_HEADER_TYPE_ACK && (header & LBM_TRANSPORT_HEADER_FLAG_RELIABLE)) {
+        // give recipient grace time of one millisecond to sort things out before we send Ack
+        k_sleep(K_MSEC(1));
+
+        // prepare Ack packet
+        prepare_ack(&data->ack_rb);
+
+        // send Ack
+        retcode = lora_p2p_network_send(data->lora_network_dev, nmeta->from, &data->ack_rb);
+        if (retcode < 0) LOG_ERR("Failed sending Ack to %d (%d)", nmeta->from, retcode);
+
+        lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_TRANSPORT, LORA_P2P_TRACE_DIR_TX,
+            retcode < 0 ? LORA_P2P_TRACE_OUTCOME_SEND_ERROR : LORA_P2P_TRACE_OUTCOME_SENT,
+            LBM_TRANSPORT_HEADER_TYPE_ACK, lora_p2p_network_get_node_id(data->lora_network_dev), nmeta->from, 1, 0, 0);
+    }
 }
 
-static int lora_p2p_transport_send_impl(const struct device *dev, uint8_t to, struct ring_buf *input, bool reliable) {
+// how long the rx thread should listen (caller holds sessions_lock):
+// for as long as a recv() waits for a message nobody has completed yet,
+// otherwise until the last pending Ack deadline, otherwise not at all
+static k_timeout_t rx_listen_timeout(struct lora_p2p_transport_data_t *data) {
+    k_timeout_t listen = K_NO_WAIT;
+    uint32_t ready = 0;
+
+    for (int i = 0; i < CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS; i++) {
+        if (data->sessions[i].in_use && data->sessions[i].rx_ready) ready++;
+    }
+
+    if (data->recv_pending > ready) return K_FOREVER;
+
+    for (int i = 0; i < CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS; i++) {
+        struct lora_p2p_transport_session_t *session = &data->sessions[i];
+
+        if (!session->in_use || !session->awaiting_ack) continue;
+
+        k_timeout_t remaining = sys_timepoint_timeout(session->ack_deadline);
+        if (remaining.ticks > listen.ticks) listen = remaining;
+    }
+
+    return listen;
+}
+
+// the only reader of the radio: routes Acks to senders and fragments to their session
+static void lora_p2p_transport_rx_thread(void *p1, void *p2, void *p3) {
+    const struct device *dev = p1;
     struct lora_p2p_transport_data_t *data = dev->data;
+    struct lora_p2p_network_incoming_t nmeta;
+    k_timeout_t listen;
+    int retcode;
 
-    uint8_t *packet;
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (true) {
+        k_mutex_lock(&data->sessions_lock, K_FOREVER);
+        listen = rx_listen_timeout(data);
+        k_mutex_unlock(&data->sessions_lock);
+
+        // nobody needs the receiver, keep the radio idle until somebody does
+        if (K_TIMEOUT_EQ(listen, K_NO_WAIT)) {
+            k_sem_take(&data->listen_sem, K_FOREVER);
+            continue;
+        }
+
+        // reset ring buffer (we want to point at the start of the memory block)
+        ring_buf_reset(&data->rx_rb);
+
+        // listen, network layer lets waiting senders in meanwhile
+        retcode = lora_p2p_network_recv(data->lora_network_dev, &nmeta, &data->rx_rb, listen);
+        if (retcode == -EAGAIN || retcode == -ETIMEDOUT) continue;
+        if (retcode < 0) {
+            LOG_WRN("Receive failed (%d)", retcode);
+            k_sleep(LBM_TRANSPORT_RX_ERROR_BACKOFF);
+            continue;
+        }
+
+        handle_frame(data, &nmeta);
+    }
+}
+
+// send all fragments of a message (caller holds session tx_lock)
+static int send_fragments(struct lora_p2p_transport_data_t *data, struct lora_p2p_transport_session_t *session,
+    uint8_t to, struct ring_buf *input, bool reliable) {
+    uint8_t header, *packet;
     uint32_t packet_size, available_size;
     int retcode;
-    struct lora_p2p_network_incoming_t meta;
     bool first_packet = true;
 
-    LOG_DBG("Sending %d bytes packet to %d", ring_buf_size_get(input), to);
-
     do {
         /* Prepare packet
         */
         // reset our buffer so we're at the begining of the memory block
-        ring_buf_reset(&data->rb);
+        ring_buf_reset(&session->tx_rb);
 
         // allocate space for packet
-        available_size = ring_buf_put_claim(&data->rb, &packet, lora_p2p_network_get_mtu(data->lora_network_dev));
+        available_size = ring_buf_put_claim(&session->tx_rb, &packet, lora_p2p_network_get_mtu(data->lora_network_dev));
 
         // get content to be sent
         packet_size = ring_buf_get(input, packet, available_size-1);
@@ -156,33 +482,67 @@ static int lora_p2p_transport_send_impl(const struct device *dev, uint8_t to, st
 
         // header: reliable transport (with Ack for each send)
         packet[packet_size] |= reliable ? LBM_TRANSPORT_HEADER_FLAG_RELIABLE : 0;
+        header = packet[packet_size];
 
         // finish claim
-        retcode = ring_buf_put_finish(&data->rb, packet_size+1);
+        retcode = ring_buf_put_finish(&session->tx_rb, packet_size+1);
+
+        // wait for our turn on air
+        k_mutex_lock(&data->air_lock, K_FOREVER);
+
+        // forget any stale Ack before the peer gets a chance to answer
+        if (reliable) {
+            k_mutex_lock(&data->sessions_lock, K_FOREVER);
+            k_sem_reset(&session->ack_sem);
+            session->awaiting_ack = true;
+            session->ack_deadline = sys_timepoint_calc(K_NO_WAIT);
+            k_mutex_unlock(&data->sessions_lock);
+        }
 
         /* Send packet
         */
-        retcode = lora_p2p_network_send(data->lora_network_dev, to, &data->rb);
-        if (retcode < 0) return retcode;
+        retcode = lora_p2p_network_send(data->lora_network_dev, to, &session->tx_rb);
+
+        lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_TRANSPORT, LORA_P2P_TRACE_DIR_TX,
+            retcode < 0 ? LORA_P2P_TRACE_OUTCOME_SEND_ERROR : LORA_P2P_TRACE_OUTCOME_SENT,
+            header, lora_p2p_network_get_node_id(data->lora_network_dev), to, packet_size+1, 0, 0);
+
+        if (retcode < 0 || !reliable) k_mutex_unlock(&data->air_lock);
+        if (retcode < 0) {
+            k_mutex_lock(&data->sessions_lock, K_FOREVER);
+            session->awaiting_ack = false;
+            k_mutex_unlock(&data->sessions_lock);
+            return retcode;
+        }
 
         /* Make it reliable if requested
         */
         if (reliable) {
-            // reset our buffer just in case
-            ring_buf_reset(&data->rb);
+            // have the rx thread listen for the Ack
+            k_mutex_lock(&data->sessions_lock, K_FOREVER);
+            session->ack_deadline = sys_timepoint_calc(LBM_TRANSPORT_ACK_TIMEOUT);
+            k_mutex_unlock(&data->sessions_lock);
+            k_sem_give(&data->listen_sem);
+
+            // keep the air clear for a prompt Ack (peer's grace time plus Ack airtime)
+            retcode = k_sem_take(&session->ack_sem, LBM_TRANSPORT_ACK_TURNAROUND);
+            k_mutex_unlock(&data->air_lock);
+
+            // a slow (or silent) peer only delays its own transfer from here on
+            if (retcode < 0) retcode = k_sem_take(&session->ack_sem, sys_timepoint_timeout(session->ack_deadline));
+
+            // stop waiting (an Ack consumed by the rx thread right at the timeout still counts)
+            k_mutex_lock(&data->sessions_lock, K_FOREVER);
+            if (retcode < 0 && !session->awaiting_ack) retcode = k_sem_take(&session->ack_sem, K_NO_WAIT);
+            session->awaiting_ack = false;
+            k_mutex_unlock(&data->sessions_lock);
 
-            // wait for Ack
-            retcode = lora_p2p_network_recv(data->lora_network_dev, &meta, &data->rb, K_SECONDS(1));
             if (retcode < 0) {
-                LOG_ERR("Timeout on Ack");
+                LOG_ERR("Timeout on Ack from %d", to);
+                lora_p2p_trace_record(LORA_P2P_TRACE_LAYER_TRANSPORT, LORA_P2P_TRACE_DIR_TX,
+                    LORA_P2P_TRACE_OUTCOME_ACK_TIMEOUT, header, lora_p2p_network_get_node_id(data->lora_network_dev), to, packet_size+1, 0, 0);
                 return retcode;
             }
-
-            // make sure this is an Ack packet
-            if (!is_ack_packet(&data->rb)) {
-                LOG_ERR("lora_p2p_transport_send_impl(): Expected Ack");
-                return -EINVAL;
-            }
         }
 
         /* Aftermath
@@ -195,76 +555,150 @@ static int lora_p2p_transport_send_impl(const struct device *dev, uint8_t to, st
 
     } while (true);
 
-    // return success
     return 0;
 }
 
-static int lora_p2p_transport_recv_impl(const struct device *dev, struct lora_p2p_transport_incoming_t *meta, struct ring_buf *output) {
-	struct lora_p2p_transport_data_t *data = dev->data;
+/* Driver init
+*/
+static int lora_p2p_transport_init(const struct device *dev) {
+    struct lora_p2p_transport_data_t *data = dev->data;
 
-    uint8_t header, *packet;
-    uint32_t available_size;
-    struct lora_p2p_network_incoming_t nmeta;
+    // assign inferiour network device
+    data->lora_network_dev = device_get_binding(LORA_P2P_NETWORK_DRIVER_NAME);
+
+    // make sure lora device is ready
+    if (!device_is_ready(data->lora_network_dev)) {
+        LOG_ERR("%s Device not ready", data->lora_network_dev->name);
+        return -EINVAL;
+    }
+
+    // initialize sessions
+    k_mutex_init(&data->air_lock);
+    k_mutex_init(&data->sessions_lock);
+    for (int i = 0; i < CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS; i++) {
+        struct lora_p2p_transport_session_t *session = &data->sessions[i];
+
+        session->in_use = false;
+        k_mutex_init(&session->tx_lock);
+        k_sem_init(&session->ack_sem, 0, 1);
+        ring_buf_init(&session->tx_rb, sizeof(session->tx_buffer), session->tx_buffer);
+        ring_buf_init(&session->rx_rb, sizeof(session->rx_buffer), session->rx_buffer);
+    }
+
+    // initialize receive path
+    k_msgq_init(&data->rx_msgq, data->rx_msgq_buffer, sizeof(uint8_t), CONFIG_LBM_P2P_TRANSPORT_MAX_SESSIONS);
+    ring_buf_init(&data->rx_rb, sizeof(data->rx_buffer), data->rx_buffer);
+    ring_buf_init(&data->ack_rb, sizeof(data->ack_buffer), data->ack_buffer);
+
+    // receive thread stays idle (radio off) until a recv() or an Ack needs it
+    data->recv_pending = 0;
+    k_sem_init(&data->listen_sem, 0, 1);
+    k_thread_create(&data->rx_thread, lora_p2p_transport_rx_stack, K_THREAD_STACK_SIZEOF(lora_p2p_transport_rx_stack),
+        lora_p2p_transport_rx_thread, (void *)dev, NULL, NULL,
+        CONFIG_LBM_P2P_TRANSPORT_RX_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&data->rx_thread, "lora_p2p_rx");
+
+    // ready !
+    LOG_INF("LoRa transport layer ready");
+
+    return 0;
+}
+
+/* Driver API
+*/
+static const struct device * lora_p2p_transport_get_network_device_impl(const struct device *dev) {
+    struct lora_p2p_transport_data_t *data = dev->data;
+
+	return data->lora_network_dev;
+}
+
+static int lora_p2p_transport_send_impl(const struct device *dev, uint8_t to, struct ring_buf *input, bool reliable) {
+    struct lora_p2p_transport_data_t *data = dev->data;
+    struct lora_p2p_transport_session_t *session;
     int retcode;
 
-    LOG_DBG("Ready to receive %d bytes at most", ring_buf_space_get(output));
+    // sanity check: Acks can not be matched to a broadcast
+    if (reliable && to == LORA_P2P_BROADCAST_ID) {
+        LOG_ERR("lora_p2p_transport_send_impl(): Reliable broadcast not supported");
+        return -EINVAL;
+    }
 
-    // receive packets while we should
-    while (true) {
-        /* Receive packet
-        */
-        // reset ring buffer (we want to point at the start of the memory block)
-        ring_buf_reset(&data->rb);
+    LOG_DBG("Sending %d bytes packet to %d", ring_buf_size_get(input), to);
 
-        // receive a packet (wait indefinetly)
-        retcode = lora_p2p_network_recv(data->lora_network_dev, &nmeta, &data->rb, K_FOREVER);
-        if (retcode < 0) return retcode;
+    // get (and pin) the session of the peer
+    k_mutex_lock(&data->sessions_lock, K_FOREVER);
+    session = session_get(data, to);
+    if (session) session->tx_users++;
+    k_mutex_unlock(&data->sessions_lock);
 
-        // update meta data
-        meta->from = nmeta.from;
-        meta->to = nmeta.to;
-        meta->rssi = nmeta.rssi;
-        meta->snr = nmeta.snr;
+    if (!session) {
+        LOG_ERR("lora_p2p_transport_send_impl(): No free session for %d", to);
+        return -EBUSY;
+    }
 
-        // claim contents
-        available_size = ring_buf_get_claim(&data->rb, &packet, lora_p2p_network_get_mtu(data->lora_network_dev));
+    // one transfer per peer, fragments to other peers interleave with ours
+    k_mutex_lock(&session->tx_lock, K_FOREVER);
+    retcode = send_fragments(data, session, to, input, reliable);
+    k_mutex_unlock(&session->tx_lock);
 
-        // we MUST have a header
-        if (available_size < 1) return -EINVAL;
+    // release the session
+    k_mutex_lock(&data->sessions_lock, K_FOREVER);
+    session->tx_users--;
+    session->last_activity = k_uptime_get_32();
+    k_mutex_unlock(&data->sessions_lock);
 
-        // parse header
-        header = packet[available_size-1];
+    return retcode;
+}
 
-        // put contents in caller ring buff
-        ring_buf_put(output, packet, available_size-1);
+static int lora_p2p_transport_recv_impl(const struct device *dev, struct lora_p2p_transport_incoming_t *meta, struct ring_buf *output) {
+	struct lora_p2p_transport_data_t *data = dev->data;
+    struct lora_p2p_transport_session_t *session;
+    uint8_t index, *payload;
+    uint32_t size;
 
-        // finish claim
-        ring_buf_get_finish(&data->rb, available_size);
+    LOG_DBG("Ready to receive %d bytes at most", ring_buf_space_get(output));
 
-        /* Make it reliable if requested
-        */
-        if (header & LBM_TRANSPORT_HEADER_FLAG_RELIABLE) {
-            // give recipient grace time of one millisecond to sort things out before we send Ack
-            k_sleep(K_MSEC(1));
+    // have the rx thread listen while we wait
+    k_mutex_lock(&data->sessions_lock, K_FOREVER);
+    data->recv_pending++;
+    k_mutex_unlock(&data->sessions_lock);
+    k_sem_give(&data->listen_sem);
 
-            // prepare Ack packet
-            prepare_ack(&data->rb);
+    // wait for a complete message from any peer
+    k_msgq_get(&data->rx_msgq, &index, K_FOREVER);
+    session = &data->sessions[index];
 
-            // send Ack
-            retcode = lora_p2p_network_send(data->lora_network_dev, nmeta.from, &data->rb);
-            if (retcode < 0) return retcode;
-        }
+    k_mutex_lock(&data->sessions_lock, K_FOREVER);
+    data->recv_pending--;
+    k_mutex_unlock(&data->sessions_lock);
 
-        /* Aftermath
-        */
-        // decide what we do now (we are done if this was a stand alone packet or a finisher)
-        if ((header & LBM_TRANSPORT_HEADER_TYPE_MASK) == LBM_TRANSPORT_HEADER_TYPE_STAND_ALONE ||
-            (header & LBM_TRANSPORT_HEADER_TYPE_MASK) == LBM_TRANSPORT_HEADER_TYPE_FINISHER
-            ) break;
+    // rx thread leaves the session alone while rx_ready is set
+    *meta = session->rx_meta;
+
+    // sanity check: message was already Acked, keep it queued so the caller can retry with a bigger buffer
+    if (ring_buf_space_get(output) < ring_buf_size_get(&session->rx_rb)) {
+        LOG_ERR("lora_p2p_transport_recv_impl(): Buffer size too small (need %d bytes)", ring_buf_size_get(&session->rx_rb));
+
+        // queue never overflows, we just took this index out
+        k_msgq_put(&data->rx_msgq, &index, K_NO_WAIT);
+        return -ENOMEM;
+    }
+
+    // put contents in caller ring buff
+    while ((size = ring_buf_get_claim(&session->rx_rb, &payload, CONFIG_LBM_P2P_TRANSPORT_MAX_MESSAGE_SIZE)) > 0) {
+        ring_buf_put(output, payload, size);
+        ring_buf_get_finish(&session->rx_rb, size);
     }
 
     LOG_DBG("  Got payload (%d bytes)", ring_buf_size_get(output));
 
+    // hand the session back to the rx thread
+    k_mutex_lock(&data->sessions_lock, K_FOREVER);
+    ring_buf_reset(&session->rx_rb);
+    session->rx_ready = false;
+    session->last_activity = k_uptime_get_32();
+    k_mutex_unlock(&data->sessions_lock);
+
     return 0;
 }
 
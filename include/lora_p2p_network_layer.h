@@ -51,6 +51,7 @@ struct lora_p2p_network_incoming_t {
 typedef const struct device * (*lora_p2p_network_api_get_link_device)(const struct device *dev);
 typedef uint32_t (*lora_p2p_network_api_get_mtu)(const struct device *dev);
 typedef int (*lora_p2p_network_api_set_node_id)(const struct device *dev, uint8_t node_id);
+typedef uint8_t (*lora_p2p_network_api_get_node_id)(const struct device *dev);
 typedef int (*lora_p2p_network_api_send)(const struct device *dev, uint8_t to, struct ring_buf *rb);
 typedef int (*lora_p2p_network_api_recv)(const struct device *dev, struct lora_p2p_network_incoming_t *meta, struct ring_buf *rb, k_timeout_t timeout);
 
@@ -58,6 +59,7 @@ __subsystem struct lora_p2p_network_driver_api {
 	lora_p2p_network_api_get_link_device get_link_device;
 	lora_p2p_network_api_get_mtu get_mtu;
 	lora_p2p_network_api_set_node_id set_node_id;
+	lora_p2p_network_api_get_node_id get_node_id;
 	lora_p2p_network_api_send send;
 	lora_p2p_network_api_recv recv;
 };
@@ -80,6 +82,10 @@ static inline int lora_p2p_network_set_node_id(const struct device *dev, uint8_t
 	return DEVICE_API_GET(lora_p2p_network, dev)->set_node_id(dev, node_id);
 }
 
+static inline uint8_t lora_p2p_network_get_node_id(const struct device *dev) {
+	return DEVICE_API_GET(lora_p2p_network, dev)->get_node_id(dev);
+}
+
 static inline int lora_p2p_network_send(const struct device *dev, uint8_t to, struct ring_buf *rb) {
 	return DEVICE_API_GET(lora_p2p_network, dev)->send(dev, to, rb);
 }
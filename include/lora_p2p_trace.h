@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 Cerbercomm LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Maintained by:
+ *   2026-10-18 agent
+ */
+
+#ifndef LORA_P2P_TRACE_H
+#define LORA_P2P_TRACE_H
+
+#include "zephyr/toolchain.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zephyr/kernel.h>
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC TYPES ------------------------------------------------------------
+*/
+// which layer saw the frame
+enum lora_p2p_trace_layer_t {
+	LORA_P2P_TRACE_LAYER_NETWORK = 0,
+	LORA_P2P_TRACE_LAYER_TRANSPORT = 1,
+};
+
+// which way the frame went
+enum lora_p2p_trace_direction_t {
+	LORA_P2P_TRACE_DIR_RX = 0,
+	LORA_P2P_TRACE_DIR_TX = 1,
+};
+
+// what became of the frame
+enum lora_p2p_trace_outcome_t {
+	// handed to the radio
+	LORA_P2P_TRACE_OUTCOME_SENT = 0,
+
+	// radio refused it
+	LORA_P2P_TRACE_OUTCOME_SEND_ERROR = 1,
+
+	// passed up to the next layer / caller
+	LORA_P2P_TRACE_OUTCOME_DELIVERED = 2,
+
+	// not addressed to us
+	LORA_P2P_TRACE_OUTCOME_FILTERED = 3,
+
+	// addressed to us but rejected (no session, out of order, too big ...)
+	LORA_P2P_TRACE_OUTCOME_DROPPED = 4,
+
+	// peer did not Ack the fragment in time
+	LORA_P2P_TRACE_OUTCOME_ACK_TIMEOUT = 5,
+};
+
+// a single trace record, also the payload of each pcap packet (little endian on all supported targets)
+struct lora_p2p_trace_entry_t {
+	// running record number, gaps mean the ring wrapped while reading
+	uint32_t seq;
+
+	// microseconds since boot
+	uint64_t timestamp_us;
+
+	// enum lora_p2p_trace_layer_t
+	uint8_t layer;
+
+	// enum lora_p2p_trace_direction_t
+	uint8_t direction;
+
+	// enum lora_p2p_trace_outcome_t
+	uint8_t outcome;
+
+	// transport header (0 at network layer)
+	uint8_t header;
+
+	// sender (our own node id for TX)
+	uint8_t from;
+
+	// recipient
+	uint8_t to;
+
+	// frame length including this layer's header
+	uint16_t length;
+
+	// RSSI / SNR of the incoming transmission (0 for TX)
+	int16_t rssi;
+	int8_t snr;
+
+	uint8_t reserved;
+} __packed;
+
+// called for each record, return non zero to stop
+typedef int (*lora_p2p_trace_cb_t)(const struct lora_p2p_trace_entry_t *entry, void *user_data);
+
+// sink for exported bytes, return negative to abort
+typedef int (*lora_p2p_trace_write_cb_t)(const void *buf, size_t len, void *user_data);
+
+/*
+ * -----------------------------------------------------------------------------
+ * --- PUBLIC API --------------------------------------------------------------
+*/
+#ifdef CONFIG_LBM_P2P_TRACE
+
+/**
+ * Record a frame. Lock free, safe to call from any thread.
+ */
+void lora_p2p_trace_record(enum lora_p2p_trace_layer_t layer, enum lora_p2p_trace_direction_t direction,
+	enum lora_p2p_trace_outcome_t outcome, uint8_t header, uint8_t from, uint8_t to, uint16_t length,
+	int16_t rssi, int8_t snr);
+
+/**
+ * Walk the records still in the ring, oldest first.
+ *
+ * @return number of records visited
+ */
+int lora_p2p_trace_foreach(lora_p2p_trace_cb_t cb, void *user_data);
+
+/**
+ * Export the records still in the ring as a pcap stream
+ * (link type CONFIG_LBM_P2P_TRACE_PCAP_LINKTYPE, one struct lora_p2p_trace_entry_t per packet).
+ *
+ * @return number of records exported or negative error from the write callback
+ */
+int lora_p2p_trace_pcap_export(lora_p2p_trace_write_cb_t write, void *user_data);
+
+/**
+ * Forget all records recorded so far.
+ */
+void lora_p2p_trace_clear(void);
+
+#ifdef CONFIG_LBM_P2P_TRACE_NATIVE_FILE
+/**
+ * native_sim only: export the records as a pcap file on the host.
+ *
+ * @return number of records exported or negative error
+ */
+int lora_p2p_trace_pcap_export_file(const char *path);
+#endif
+
+#else
+
+static inline void lora_p2p_trace_record(enum lora_p2p_trace_layer_t layer, enum lora_p2p_trace_direction_t direction,
+	enum lora_p2p_trace_outcome_t outcome, uint8_t header, uint8_t from, uint8_t to, uint16_t length,
+	int16_t rssi, int8_t snr) {
+	ARG_UNUSED(layer); ARG_UNUSED(direction); ARG_UNUSED(outcome); ARG_UNUSED(header);
+	ARG_UNUSED(from); ARG_UNUSED(to); ARG_UNUSED(length); ARG_UNUSED(rssi); ARG_UNUSED(snr);
+}
+
+#endif  // CONFIG_LBM_P2P_TRACE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // LORA_P2P_TRACE_H